@@ -1,3 +1,16 @@
+// Counts the per-pixel rendering work and outputs it as a heatmap instead of the image
+//#define INSTRUMENTATION
+// Writes the raw counters (intersection tests, shadow rays, bounces) into the color channels instead of the heatmap
+//#define INSTRUMENTATION_RAW
+// Counter shown by the heatmap: 0 = primitive tests, 1 = scene traversals, 2 = shadow rays, 3 = bounces
+#define INSTRUMENTATION_COUNTER 0
+// Counter value shown as the hottest heatmap color
+#define INSTRUMENTATION_MAX 64.0
+// Writes linear radiance for a floating point render target and leaves tonemapping to the tonemap.c pass
+//#define HDR_OUTPUT
+// Only shades the fragments inside the tile uniform, so a frame can be rendered and written out tile by tile
+//#define TILED_OUTPUT
+
 precision highp float;
 
 struct PointLight {
@@ -60,6 +73,47 @@ struct HitInfo {
   Material material;
 };
 
+#ifdef INSTRUMENTATION
+// Per-pixel work counters, reset at the start of main()
+int primitiveTestCount;
+int sceneTraversalCount;
+int shadowRayCount;
+int bounceCount;
+
+void resetInstrumentation() {
+  primitiveTestCount = 0;
+  sceneTraversalCount = 0;
+  shadowRayCount = 0;
+  bounceCount = 0;
+}
+
+// Maps a cost in [0, 1] to a blue-green-red heatmap color
+vec3 heatmap(const float cost) {
+  float c = clamp(cost, 0.0, 1.0);
+  return c < 0.5 ? 
+    mix(vec3(0, 0, 1), vec3(0, 1, 0), 2.0 * c) : 
+    mix(vec3(0, 1, 0), vec3(1, 0, 0), 2.0 * c - 1.0);
+}
+
+vec3 instrumentationColor() {
+#ifdef INSTRUMENTATION_RAW
+  // In steps of 1/255, so reading back an 8-bit framebuffer gives the counts as long as they stay below 256.
+  // Summing the read back pixels gives the per-frame totals.
+  return vec3(float(primitiveTestCount), float(shadowRayCount), float(bounceCount)) / 255.0;
+#else
+  int count = primitiveTestCount;
+#if INSTRUMENTATION_COUNTER == 1
+  count = sceneTraversalCount;
+#elif INSTRUMENTATION_COUNTER == 2
+  count = shadowRayCount;
+#elif INSTRUMENTATION_COUNTER == 3
+  count = bounceCount;
+#endif
+  return heatmap(float(count) / INSTRUMENTATION_MAX);
+#endif
+}
+#endif
+
 HitInfo getEmptyHit() {
   return HitInfo(
     false, 
@@ -207,6 +261,10 @@ HitInfo intersectScene(const Scene scene, const Ray ray, const float tMin, const
   HitInfo bestHitInfo;
   bestHitInfo.t = tMax;
   bestHitInfo.hit = false;
+#ifdef INSTRUMENTATION
+  sceneTraversalCount++;
+  primitiveTestCount += cylinderCount + sphereCount + planeCount;
+#endif
   for (int i = 0; i < cylinderCount; ++i) {
     bestHitInfo = getBetterHitInfo(bestHitInfo, intersectCylinder(ray, scene.cylinders[i], tMin, tMax));
   }
@@ -235,6 +293,9 @@ vec3 shadeFromLight(
   float specular_term  = pow(max(0.0, dot(lightDirection, reflectedDirection)), hit_info.material.glossiness);
   // Put your shadow test here
   float visibility = 1.0;
+#ifdef INSTRUMENTATION
+  shadowRayCount++;
+#endif
   HitInfo hit = intersectScene(scene, Ray(hit_info.position, hitToLight), 0.01, 1.0);
   if (hit.hit) {                                                    // Check if ray from surface to light intersects anything
     visibility = 0.0;                                               // If yes then visibility is 0 -> shadow
@@ -305,6 +366,9 @@ vec3 colorForFragment(const Scene scene, const vec2 fragCoord) {
     for(int i = 0; i < maxReflectionStepCount; i++) {
       
       if(!currentHitInfo.hit) break;
+#ifdef INSTRUMENTATION
+      bounceCount++;
+#endif
       
       // Update this with the correct values
       reflectionWeight *= currentHitInfo.material.reflectiveness;
@@ -335,6 +399,9 @@ vec3 colorForFragment(const Scene scene, const vec2 fragCoord) {
     for(int i = 0; i < maxRefractionStepCount; i++) {
       
       if(!currentHitInfo.hit) break;
+#ifdef INSTRUMENTATION
+      bounceCount++;
+#endif
 
       // Update this with the correct values
       refractionWeight *= currentHitInfo.material.refractiveness;           
@@ -377,12 +444,32 @@ Material getSteelMirrorMaterial() {
 }
 
 vec3 tonemap(const vec3 radiance) {
+#ifdef HDR_OUTPUT
+  // Done by the separate tonemap.c pass
+  return radiance;
+#else
   const float monitorGamma = 2.0;
   return pow(radiance, vec3(1.0 / monitorGamma));
+#endif
 }
 
+#ifdef TILED_OUTPUT
+// Pixel rectangle (x, y, width, height) of the tile currently being rendered
+uniform ivec4 tile;
+
+bool isFragmentInTile(const vec2 fragCoord) {
+  vec2 tileMin = vec2(tile.xy);
+  vec2 tileMax = vec2(tile.xy + tile.zw);
+  return all(greaterThanEqual(fragCoord, tileMin)) && all(lessThan(fragCoord, tileMax));
+}
+#endif
+
 void main()
 {
+#ifdef TILED_OUTPUT
+    if(!isFragmentInTile(gl_FragCoord.xy)) discard;
+#endif
+
     // Setup scene
     Scene scene;
     scene.ambient = vec3(0.12, 0.15, 0.2);
@@ -422,6 +509,12 @@ void main()
     scene.cylinders[1].material       = getPlasticMaterial();
 
   // compute color for fragment
+#ifdef INSTRUMENTATION
+  resetInstrumentation();
+  colorForFragment(scene, gl_FragCoord.xy);
+  gl_FragColor.rgb = instrumentationColor();
+#else
   gl_FragColor.rgb = tonemap(colorForFragment(scene, gl_FragCoord.xy));
+#endif
   gl_FragColor.a = 1.0;
 }
@@ -4,6 +4,16 @@
 //#define SOLUTION_HALTON
 //#define SOLUTION_NEXT_EVENT_ESTIMATION
 #define SOLUTION_AA
+// Counts the per-pixel rendering work and outputs it as a heatmap instead of the image.
+// Bypass the framework's Tonemapping tab (or set it to identity) while this is on, so the colors keep the counter scale.
+//#define INSTRUMENTATION
+// Writes the raw counters (intersection tests, scene traversals, path length) into the color channels instead of the heatmap
+//#define INSTRUMENTATION_RAW
+// Counter shown by the heatmap: 0 = primitive tests, 1 = scene traversals, 2 = path length
+// There is no shadow ray counter, as this tracer casts no shadow rays until next event estimation is implemented
+#define INSTRUMENTATION_COUNTER 0
+// Counter value shown as the hottest heatmap color
+#define INSTRUMENTATION_MAX 32.0
 
 precision highp float;
 
@@ -58,6 +68,44 @@ struct HitInfo {
   Material material;
 };
 
+#ifdef INSTRUMENTATION
+// Per-pixel work counters, reset at the start of main()
+int primitiveTestCount;
+int sceneTraversalCount;
+int pathLengthReached;
+
+void resetInstrumentation() {
+  primitiveTestCount = 0;
+  sceneTraversalCount = 0;
+  pathLengthReached = 0;
+}
+
+// Maps a cost in [0, 1] to a blue-green-red heatmap color
+vec3 heatmap(const float cost) {
+  float c = clamp(cost, 0.0, 1.0);
+  return c < 0.5 ? 
+    mix(vec3(0, 0, 1), vec3(0, 1, 0), 2.0 * c) : 
+    mix(vec3(0, 1, 0), vec3(1, 0, 0), 2.0 * c - 1.0);
+}
+
+vec3 instrumentationColor() {
+#ifdef INSTRUMENTATION_RAW
+  // In steps of 1/255. The framework averages the iterations, so multiplying by 255 gives the mean
+  // count per sample, which an 8-bit target only holds approximately. The per-frame totals are the
+  // summed mean counts times the number of samples.
+  return vec3(float(primitiveTestCount), float(sceneTraversalCount), float(pathLengthReached)) / 255.0;
+#else
+  int count = primitiveTestCount;
+#if INSTRUMENTATION_COUNTER == 1
+  count = sceneTraversalCount;
+#elif INSTRUMENTATION_COUNTER == 2
+  count = pathLengthReached;
+#endif
+  return heatmap(float(count) / INSTRUMENTATION_MAX);
+#endif
+}
+#endif
+
 HitInfo getEmptyHit() {
   Material emptyMaterial;
 #ifdef SOLUTION_LIGHT  
@@ -161,6 +209,10 @@ HitInfo intersectScene(Scene scene, Ray ray, const float tMin, const float tMax)
     HitInfo best_hit_info;
     best_hit_info.t = tMax;
   	best_hit_info.hit = false;
+#ifdef INSTRUMENTATION
+    sceneTraversalCount++;
+    primitiveTestCount += sphereCount + planeCount;
+#endif
 
     for (int i = 0; i < sphereCount; ++i) {
         Sphere sphere = scene.spheres[i];
@@ -427,6 +479,9 @@ vec3 samplePath(const Scene scene, const Ray initialRay) {
     HitInfo hitInfo = intersectScene(scene, incomingRay, 0.001, 10000.0); 
     
     if(!hitInfo.hit) return result;
+#ifdef INSTRUMENTATION
+    pathLengthReached = i + 1;
+#endif
          
 #ifdef SOLUTION_NEXT_EVENT_ESTIMATION   
     // Put the next event-estimation code here   
@@ -574,6 +629,13 @@ void main() {
   loadScene1(scene);
 
   // compute color for fragment
+#ifdef INSTRUMENTATION
+  resetInstrumentation();
+  colorForFragment(scene, gl_FragCoord.xy);
+  gl_FragColor.rgb = instrumentationColor();
+#else
+  // Linear radiance, tone-mapped and gamma-corrected by the framework's Tonemapping tab
   gl_FragColor.rgb = colorForFragment(scene, gl_FragCoord.xy);
+#endif
   gl_FragColor.a = 1.0;
 }
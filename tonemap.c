@@ -0,0 +1,20 @@
+// Tonemapping pass for the linear HDR output of cw1.js (HDR_OUTPUT).
+// Applies the same gamma curve as tonemap() in cw1.js, so the result matches the LDR output.
+// cw3.c is tone-mapped by the framework's Tonemapping tab instead.
+
+// Scale applied to the radiance before the gamma curve
+#define EXPOSURE 1.0
+
+precision highp float;
+
+uniform sampler2D radiance;
+uniform ivec2 resolution;
+
+const float monitorGamma = 2.0;
+
+void main() {
+  vec3 linearRadiance = texture2D(radiance, gl_FragCoord.xy / vec2(resolution)).rgb;
+
+  gl_FragColor.rgb = pow(EXPOSURE * linearRadiance, vec3(1.0 / monitorGamma));
+  gl_FragColor.a = 1.0;
+}